@@ -0,0 +1,265 @@
+// CSVIndexer.cpp
+
+#include "CSVIndexer.h"
+#include <cstring>
+#include <fstream>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    //bitmasks of the interesting characters in one 64-byte block (bit i = byte i)
+    struct BlockMasks
+    {
+        uint64_t quotes;
+        uint64_t commas;
+        uint64_t newlines;
+    };
+
+#if defined(__AVX2__)
+    inline uint64_t matchBytes(__m256i lo, __m256i hi, char c)
+    {
+        const __m256i needle = _mm256_set1_epi8(c);
+        uint64_t a = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, needle)));
+        uint64_t b = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, needle)));
+        return a | (b << 32);
+    }
+
+    inline BlockMasks scanBlock(const char *block)
+    {
+        const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+        const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32));
+        return {matchBytes(lo, hi, '"'), matchBytes(lo, hi, ','), matchBytes(lo, hi, '\n')};
+    }
+#elif defined(__SSE2__)
+    inline uint64_t matchBytes(const __m128i in[4], char c)
+    {
+        const __m128i needle = _mm_set1_epi8(c);
+        uint64_t mask = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            uint64_t bits = static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(in[i], needle)));
+            mask |= bits << (16 * i);
+        }
+        return mask;
+    }
+
+    inline BlockMasks scanBlock(const char *block)
+    {
+        __m128i in[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            in[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * i));
+        }
+        return {matchBytes(in, '"'), matchBytes(in, ','), matchBytes(in, '\n')};
+    }
+#else
+    inline BlockMasks scanBlock(const char *block)
+    {
+        BlockMasks m = {0, 0, 0};
+        for (int i = 0; i < 64; ++i)
+        {
+            uint64_t bit = uint64_t(1) << i;
+            m.quotes |= (block[i] == '"') ? bit : 0;
+            m.commas |= (block[i] == ',') ? bit : 0;
+            m.newlines |= (block[i] == '\n') ? bit : 0;
+        }
+        return m;
+    }
+#endif
+
+    //bit i of the result is the XOR of bits 0..i, i.e. set while inside a quoted region
+    inline uint64_t prefixXor(uint64_t bits)
+    {
+#if defined(__PCLMUL__)
+        //carry-less multiply by all ones
+        const __m128i all = _mm_set1_epi8(static_cast<char>(0xFF));
+        return static_cast<uint64_t>(_mm_cvtsi128_si64(
+            _mm_clmulepi64_si128(_mm_set_epi64x(0, static_cast<long long>(bits)), all, 0)));
+#else
+        bits ^= bits << 1;
+        bits ^= bits << 2;
+        bits ^= bits << 4;
+        bits ^= bits << 8;
+        bits ^= bits << 16;
+        bits ^= bits << 32;
+        return bits;
+#endif
+    }
+}
+
+//constructor
+CSVIndexer::CSVIndexer() : buffer(nullptr)
+{
+}
+
+//index a buffer block by block
+void CSVIndexer::index(const char *data, size_t len)
+{
+    buffer = data;
+    fieldEnds.clear();
+    rowEnds.clear();
+
+    //a guess: the tweet files average about 22 bytes per field and 137 per row, so these cover them
+    //without regrowth; files of short fields, like the ground truth (about 7 per field), regrow a few times
+    fieldEnds.reserve(len / 16 + 1);
+    rowEnds.reserve(len / 64 + 1);
+
+    uint64_t inQuotes = 0; //all ones if the previous block ended inside quotes
+    char tail[64];
+
+    for (size_t base = 0; base < len; base += 64)
+    {
+        const char *block = data + base;
+        if (len - base < 64)
+        {
+            //pad the last partial block with zeros
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, block, len - base);
+            block = tail;
+        }
+
+        BlockMasks m = scanBlock(block);
+        uint64_t quoted = prefixXor(m.quotes) ^ inQuotes;
+
+        //like parseCSVLine, every line starts unquoted: a line left inside quotes by a stray '"'
+        //flips the parity of everything after its newline back
+        uint64_t newlines = m.newlines;
+        while (newlines)
+        {
+            unsigned bit = static_cast<unsigned>(__builtin_ctzll(newlines));
+            if (((quoted >> bit) & 1) && bit < 63)
+            {
+                quoted ^= ~uint64_t(0) << (bit + 1);
+            }
+            newlines &= newlines - 1;
+        }
+        bool endsWithNewline = (m.newlines >> 63) & 1;
+        inQuotes = endsWithNewline ? 0 : static_cast<uint64_t>(static_cast<int64_t>(quoted) >> 63);
+
+        uint64_t structural = (m.commas & ~quoted) | m.newlines;
+        while (structural)
+        {
+            unsigned bit = static_cast<unsigned>(__builtin_ctzll(structural));
+            fieldEnds.push_back(base + bit);
+            if (m.newlines & (uint64_t(1) << bit))
+            {
+                rowEnds.push_back(fieldEnds.size());
+            }
+            structural &= structural - 1;
+        }
+    }
+
+    //the last row has no newline after it
+    size_t lastRowStart = rowEnds.empty() ? 0 : fieldEnds[rowEnds.back() - 1] + 1;
+    if (lastRowStart < len)
+    {
+        fieldEnds.push_back(len);
+        rowEnds.push_back(fieldEnds.size());
+    }
+}
+
+//number of rows
+size_t CSVIndexer::rowCount() const
+{
+    return rowEnds.size();
+}
+
+//index of the first field of a row in fieldEnds
+size_t CSVIndexer::firstField(size_t row) const
+{
+    return (row == 0) ? 0 : rowEnds[row - 1];
+}
+
+//offset where a field starts, just past the previous separator
+size_t CSVIndexer::fieldStart(size_t fieldIndex) const
+{
+    return (fieldIndex == 0) ? 0 : fieldEnds[fieldIndex - 1] + 1;
+}
+
+//number of fields in a row
+size_t CSVIndexer::fieldCount(size_t row) const
+{
+    return rowEnds[row] - firstField(row);
+}
+
+//start offset of a row
+size_t CSVIndexer::rowBegin(size_t row) const
+{
+    return fieldStart(firstField(row));
+}
+
+//end offset of a row (its newline, or the end of the buffer)
+size_t CSVIndexer::rowEnd(size_t row) const
+{
+    return fieldEnds[rowEnds[row] - 1];
+}
+
+//decode one field
+void CSVIndexer::field(size_t row, size_t col, std::string &out) const
+{
+    size_t k = firstField(row) + col;
+    const char *begin = buffer + fieldStart(k);
+    const char *end = buffer + fieldEnds[k];
+    size_t n = static_cast<size_t>(end - begin);
+
+    //most fields have no quotes and are copied as is
+    if (std::memchr(begin, '"', n) == nullptr)
+    {
+        out.assign(begin, n);
+        return;
+    }
+
+    //same rules as parseCSVLine: quotes toggle, "" inside quotes is a literal quote
+    out.clear();
+    out.reserve(n);
+    bool quotedNow = false;
+    for (const char *p = begin; p < end; ++p)
+    {
+        if (*p == '"')
+        {
+            if (quotedNow && p + 1 < end && p[1] == '"')
+            {
+                out += '"';
+                ++p;
+            }
+            else
+            {
+                quotedNow = !quotedNow;
+            }
+        }
+        else
+        {
+            out += *p;
+        }
+    }
+}
+
+//decode all fields of a row
+void CSVIndexer::fields(size_t row, std::vector<std::string> &out) const
+{
+    size_t count = fieldCount(row);
+    out.resize(count);
+    for (size_t col = 0; col < count; ++col)
+    {
+        field(row, col, out[col]);
+    }
+}
+
+//read a whole file into a string
+bool CSVIndexer::loadFile(const std::string &path, std::string &buffer)
+{
+    std::ifstream infile(path, std::ios::binary);
+    if (!infile.is_open())
+    {
+        return false;
+    }
+    infile.seekg(0, std::ios::end);
+    std::streamoff size = infile.tellg();
+    infile.seekg(0, std::ios::beg);
+    buffer.resize(size > 0 ? static_cast<size_t>(size) : 0);
+    infile.read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
+    return true;
+}
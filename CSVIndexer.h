@@ -0,0 +1,56 @@
+// CSVIndexer.h
+
+#ifndef CSVINDEXER_H
+#define CSVINDEXER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//structural indexer for a whole CSV buffer
+//the buffer is scanned in 64-byte blocks: quote, comma and newline positions become bitmasks,
+//a prefix XOR over the quote bits marks the quoted regions, and every unquoted comma and every
+//newline is recorded as a field end. as in parseCSVLine, quotes never span lines: each newline
+//ends the row and resets the quote state. rows and fields are then just offsets into the buffer.
+class CSVIndexer {
+private:
+    const char *buffer; //the indexed buffer (not owned)
+
+    //offset of the separator (',' or '\n') or end of buffer that ends each field, in order
+    std::vector<size_t> fieldEnds;
+
+    //for each row, the index one past its last field in fieldEnds
+    std::vector<size_t> rowEnds;
+
+    size_t firstField(size_t row) const;
+    size_t fieldStart(size_t fieldIndex) const;
+
+public:
+    //constructor
+    CSVIndexer();
+
+    //index a buffer; the buffer must stay alive while fields are read
+    void index(const char *data, size_t len);
+
+    //number of rows found (a trailing newline does not start a new row)
+    size_t rowCount() const;
+
+    //number of fields in the given row
+    size_t fieldCount(size_t row) const;
+
+    //decode one field, removing quotes and turning "" into " the same way parseCSVLine does
+    void field(size_t row, size_t col, std::string &out) const;
+
+    //decode all fields of a row
+    void fields(size_t row, std::vector<std::string> &out) const;
+
+    //byte range [begin, end) of a row in the buffer, without its newline
+    size_t rowBegin(size_t row) const;
+    size_t rowEnd(size_t row) const;
+
+    //read a whole file into buffer; returns false if the file cannot be opened
+    static bool loadFile(const std::string &path, std::string &buffer);
+};
+
+#endif //CSVINDEXER_H
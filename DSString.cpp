@@ -3,57 +3,93 @@
 #include "DSString.h"
 #include <vector>
 #include <cctype> //for std::tolower
+#include <cstring> //for std::strlen, std::memcpy
+#include <cstdint>
 
 //helper function to compute the length of a C-string
+//std::strlen scans a word/vector at a time instead of byte by byte
 size_t my_strlen(const char *str) {
-    size_t i = 0;
-    while (str[i] != '\0') {
-        ++i;
-    }
-    return i;
+    return std::strlen(str);
+}
+
+//loads 8 bytes from any address (compiles to a single unaligned load)
+static inline uint64_t load_word(const char *p) {
+    uint64_t w;
+    std::memcpy(&w, p, sizeof(w));
+    return w;
 }
 
-//helper function to copy a C-string
-void my_strcpy(char *dest, const char *src) {
+//helper function to copy n characters, 8 bytes at a time, and terminate dest
+void my_strcpy(char *dest, const char *src, size_t n) {
     size_t i = 0;
-    while (src[i] != '\0') {
+    for (; i + 8 <= n; i += 8) {
+        uint64_t w = load_word(src + i);
+        std::memcpy(dest + i, &w, sizeof(w));
+    }
+    for (; i < n; ++i) {
         dest[i] = src[i];
-        ++i;
     }
-    dest[i] = '\0';
+    dest[n] = '\0';
 }
 
-//helper function to concatenate two C-strings
-void my_strcat(char *dest, const char *src) {
-    size_t dest_len = my_strlen(dest);
-    size_t i = 0;
-    while (src[i] != '\0') {
-        dest[dest_len + i] = src[i];
-        ++i;
-    }
-    dest[dest_len + i] = '\0';
+//helper function to append src (srcLen characters) to dest, whose length is already known
+void my_strcat(char *dest, size_t destLen, const char *src, size_t srcLen) {
+    my_strcpy(dest + destLen, src, srcLen);
 }
 
-//helper function to compare two C-strings
-int my_strcmp(const char *str1, const char *str2) {
+//helper function to compare two strings of known length, 8 bytes at a time
+//orders like strcmp: first differing byte decides, otherwise the shorter string is smaller
+int my_strcmp(const char *str1, size_t len1, const char *str2, size_t len2) {
+    size_t n = (len1 < len2) ? len1 : len2;
     size_t i = 0;
-    while (str1[i] != '\0' && str2[i] != '\0') {
+    for (; i + 8 <= n; i += 8) {
+        if (load_word(str1 + i) != load_word(str2 + i)) {
+            break; //the byte loop below finds the differing byte
+        }
+    }
+    for (; i < n; ++i) {
         if (str1[i] != str2[i]) {
             return (unsigned char)str1[i] - (unsigned char)str2[i];
         }
-        ++i;
     }
-    return (unsigned char)str1[i] - (unsigned char)str2[i];
+    return (len1 < len2) ? -1 : (len1 > len2) ? 1 : 0;
 }
 
-//helper function to copy 'n' characters
-void my_strncpy(char *dest, const char *src, size_t n) {
+//hash of n bytes, mixing 8 bytes per step (multiply/xorshift, murmur3-style finalizer)
+size_t DSString::hashBytes(const char *str, size_t n) noexcept {
+    const uint64_t k = 0x9E3779B97F4A7C15ULL;
+    uint64_t h = n * k;
     size_t i = 0;
-    while (i < n && src[i] != '\0') {
-        dest[i] = src[i];
-        ++i;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t w = load_word(str + i) * k;
+        w ^= w >> 32;
+        h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
+    }
+    if (i < n) {
+        uint64_t w = 0;
+        std::memcpy(&w, str + i, n - i);
+        w *= k;
+        w ^= w >> 32;
+        h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
     }
-    dest[i] = '\0'; // Ensure null termination
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return static_cast<size_t>(h);
+}
+
+//hash of n bytes as hash() would return it; never 0, which means "not computed yet"
+size_t DSString::hashOf(const char *str, size_t n) noexcept {
+    size_t h = hashBytes(str, n);
+    return (h == 0) ? 1 : h;
+}
+
+//returns the hash, computing it on first use
+size_t DSString::hash() const noexcept {
+    if (hashValue == 0) {
+        hashValue = hashOf(data, len);
+    }
+    return hashValue;
 }
 
 //default constructor
@@ -61,6 +97,7 @@ DSString::DSString() {
     data = new char[1];
     data[0] = '\0';
     len = 0;
+    hashValue = 0;
 }
 
 //constructor from C-string
@@ -68,19 +105,38 @@ DSString::DSString(const char *str) {
     if (str) {
         len = my_strlen(str);
         data = new char[len + 1];
-        my_strcpy(data, str);
+        my_strcpy(data, str, len);
     } else {
         data = new char[1];
         data[0] = '\0';
         len = 0;
     }
+    hashValue = 0;
+}
+
+//constructor from a character array of known length
+DSString::DSString(const char *str, size_t n) {
+    len = n;
+    data = new char[len + 1];
+    my_strcpy(data, str, len);
+    hashValue = 0;
+}
+
+//constructor from two character arrays of known length, placed back to back
+DSString::DSString(const char *first, size_t firstLen, const char *second, size_t secondLen) {
+    len = firstLen + secondLen;
+    data = new char[len + 1];
+    my_strcpy(data, first, firstLen);
+    my_strcat(data, firstLen, second, secondLen);
+    hashValue = 0;
 }
 
 //copy constructor
 DSString::DSString(const DSString &other) {
     len = other.len;
     data = new char[len + 1];
-    my_strcpy(data, other.data);
+    my_strcpy(data, other.data, len);
+    hashValue = other.hashValue;
 }
 
 //copy assignment operator
@@ -89,7 +145,8 @@ DSString &DSString::operator=(const DSString &other) {
         delete[] data;
         len = other.len;
         data = new char[len + 1];
-        my_strcpy(data, other.data);
+        my_strcpy(data, other.data, len);
+        hashValue = other.hashValue;
     }
     return *this;
 }
@@ -100,12 +157,13 @@ DSString &DSString::operator=(const char *str) {
     if (str) {
         len = my_strlen(str);
         data = new char[len + 1];
-        my_strcpy(data, str);
+        my_strcpy(data, str, len);
     } else {
         data = new char[1];
         data[0] = '\0';
         len = 0;
     }
+    hashValue = 0;
     return *this;
 }
 
@@ -120,34 +178,37 @@ size_t DSString::length() const {
 }
 
 //returns a reference to the character at the given index
+//the caller may modify the character, so the cached hash is dropped
 char &DSString::operator[](size_t index) {
+    hashValue = 0;
     return data[index];
 }
 
 //concatenation operator
 DSString DSString::operator+(const DSString &other) const {
-    size_t newLen = len + other.len;
-    char *newData = new char[newLen + 1];
-    my_strcpy(newData, data);
-    my_strcat(newData, other.data);
-    DSString result(newData);
-    delete[] newData;
-    return result;
+    return DSString(data, len, other.data, other.len);
 }
 
 //equality operator
 bool DSString::operator==(const DSString &other) const noexcept {
-    return my_strcmp(data, other.data) == 0;
+    //different lengths or different cached hashes can never be equal
+    if (len != other.len) {
+        return false;
+    }
+    if (hashValue != 0 && other.hashValue != 0 && hashValue != other.hashValue) {
+        return false;
+    }
+    return my_strcmp(data, len, other.data, other.len) == 0;
 }
 
 //less than operator
 bool DSString::operator<(const DSString &other) const noexcept{
-    return my_strcmp(data, other.data) < 0;
+    return my_strcmp(data, len, other.data, other.len) < 0;
 }
 
 //greater than operator
 bool DSString::operator>(const DSString &other) const noexcept{
-    return my_strcmp(data, other.data) > 0;
+    return my_strcmp(data, len, other.data, other.len) > 0;
 }
 
 //not equal operator
@@ -168,19 +229,12 @@ bool DSString::operator>=(const DSString &other) const noexcept{
 //substring method
 DSString DSString::substring(size_t start, size_t numChars) const {
     if (start >= len) {
-        return DSString("");
+        return DSString();
     }
     if (start + numChars > len) {
         numChars = len - start;
     }
-    char *subData = new char[numChars + 1];
-    for (size_t i = 0; i < numChars; ++i) {
-        subData[i] = data[start + i];
-    }
-    subData[numChars] = '\0';
-    DSString result(subData);
-    delete[] subData;
-    return result;
+    return DSString(data + start, numChars);
 }
 
 //converts to lowercase
@@ -189,6 +243,7 @@ DSString DSString::toLower() const {
     for (size_t i = 0; i < len; ++i) {
         result.data[i] = std::tolower(result.data[i]);
     }
+    result.hashValue = 0;
     return result;
 }
 
@@ -6,17 +6,24 @@
 #include <iostream>
 #include <functional> //include this for std::hash
 #include <cstddef>    //for std::size_t
+#include <vector>
 
 class DSString
 {
 private:
     char *data; //pointer to a character array containing the string with a '\0' terminator
     size_t len; //the length of the string (without the terminator)
+    mutable size_t hashValue; //cached hash, 0 until hash() is first called
+
+    static size_t hashBytes(const char *, size_t) noexcept;
+
+    DSString(const char *, size_t, const char *, size_t); //concatenation of two arrays, used by operator+
 
 public:
     //constructors, Destructor, and Assignment Operator (Rule of Three)
     DSString();
     DSString(const char *);
+    DSString(const char *, size_t); //from the first n characters, when the length is already known
     DSString(const DSString &);
     DSString &operator=(const DSString &);
     ~DSString();
@@ -41,6 +48,12 @@ public:
 
     const char *c_str() const noexcept;
 
+    //hash of the contents, computed once and cached
+    //the first call writes the cache, so a string read by several threads at once must be hashed
+    //before it is shared; after that, hash() only reads
+    size_t hash() const noexcept;
+    static size_t hashOf(const char *, size_t) noexcept; //the same hash for n bytes that are not a DSString
+
     friend std::ostream &operator<<(std::ostream &, const DSString &);
 
     //friend declaration for std::hash
@@ -56,15 +69,8 @@ namespace std
     {
         std::size_t operator()(const DSString &s) const noexcept
         {
-            //simple hash function (djb2 algorithm)
-            const char *str = s.c_str();
-            std::size_t hash = 5381;
-            int c;
-            while ((c = *str++))
-            {
-                hash = ((hash << 5) + hash) + c; //hash * 33 + c
-            }
-            return hash;
+            //8-bytes-at-a-time hash, cached inside the string
+            return s.hash();
         }
     };
 }
@@ -0,0 +1,204 @@
+// FieldDecoder.cpp
+
+#include "FieldDecoder.h"
+#include <charconv>
+#include <sstream>
+
+namespace
+{
+    bool isBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    //std::from_chars over the field without surrounding blanks; the whole rest must be the number
+    template <typename T>
+    DecodeStatus decodeNumber(const std::string &field, T &out) noexcept
+    {
+        const char *begin = field.data();
+        const char *end = begin + field.size();
+        while (begin < end && isBlank(*begin))
+        {
+            ++begin;
+        }
+        while (end > begin && isBlank(end[-1]))
+        {
+            --end;
+        }
+
+        std::from_chars_result result = std::from_chars(begin, end, out);
+        if (result.ec == std::errc::result_out_of_range)
+        {
+            return DecodeStatus::OutOfRange;
+        }
+        if (result.ec != std::errc() || result.ptr != end)
+        {
+            return DecodeStatus::Malformed;
+        }
+        return DecodeStatus::Ok;
+    }
+}
+
+//decode a label
+DecodeStatus decodeLabel(const std::string &field, int &out) noexcept
+{
+    return decodeNumber(field, out);
+}
+
+//decode a tweet ID, rejecting leading zeros
+DecodeStatus decodeID(const std::string &field, uint64_t &out) noexcept
+{
+    size_t first = 0;
+    while (first < field.size() && isBlank(field[first]))
+    {
+        ++first;
+    }
+    if (first + 1 < field.size() && field[first] == '0' && field[first + 1] >= '0' && field[first + 1] <= '9')
+    {
+        return DecodeStatus::Malformed;
+    }
+    return decodeNumber(field, out);
+}
+
+//constructor
+RowErrorLog::RowErrorLog(const std::string &source, size_t detailLimit) : source(source), detailLimit(detailLimit)
+{
+    for (size_t &c : counts)
+    {
+        c = 0;
+    }
+}
+
+//count one bad row, keeping a description of the first few of each category
+void RowErrorLog::record(Category category, size_t lineNumber, const std::string &value)
+{
+    counts[category]++;
+    if (details[category].size() < detailLimit)
+    {
+        std::ostringstream detail;
+        detail << "line " << lineNumber << ": " << categoryName(category);
+        if (!value.empty())
+        {
+            detail << " '" << value << "'";
+        }
+        details[category].push_back(detail.str());
+    }
+}
+
+//add another log's counts and details
+void RowErrorLog::merge(const RowErrorLog &other)
+{
+    for (int c = 0; c < CATEGORY_COUNT; ++c)
+    {
+        counts[c] += other.counts[c];
+        for (const std::string &detail : other.details[c])
+        {
+            if (details[c].size() >= detailLimit)
+            {
+                break;
+            }
+            details[c].push_back(detail);
+        }
+    }
+}
+
+//number of bad rows in a category
+size_t RowErrorLog::count(Category category) const
+{
+    return counts[category];
+}
+
+//number of bad rows overall
+size_t RowErrorLog::total() const
+{
+    size_t sum = 0;
+    for (size_t c : counts)
+    {
+        sum += c;
+    }
+    return sum;
+}
+
+//write the summary in one go
+void RowErrorLog::report(std::ostream &os) const
+{
+    if (total() == 0)
+    {
+        return;
+    }
+
+    std::ostringstream out;
+    out << source << ": skipped " << total() << " malformed rows (";
+    bool first = true;
+    for (int c = 0; c < CATEGORY_COUNT; ++c)
+    {
+        if (counts[c] > 0)
+        {
+            out << (first ? "" : ", ") << categoryName(static_cast<Category>(c)) << ": " << counts[c];
+            first = false;
+        }
+    }
+    out << ")\n";
+
+    for (int c = 0; c < CATEGORY_COUNT; ++c)
+    {
+        for (const std::string &detail : details[c])
+        {
+            out << "  " << detail << '\n';
+        }
+        if (counts[c] > details[c].size())
+        {
+            out << "  ... " << counts[c] - details[c].size() << " more " << categoryName(static_cast<Category>(c))
+                << '\n';
+        }
+    }
+    os << out.str();
+}
+
+//human-readable category name
+const char *RowErrorLog::categoryName(Category category)
+{
+    switch (category)
+    {
+    case TOO_FEW_FIELDS:
+        return "not enough fields";
+    case MALFORMED_LABEL:
+        return "malformed sentiment";
+    case LABEL_OUT_OF_RANGE:
+        return "sentiment out of range";
+    case INVALID_SENTIMENT:
+        return "invalid sentiment value";
+    case MALFORMED_ID:
+        return "malformed tweet ID";
+    default:
+        return "unknown";
+    }
+}
+
+//decode a sentiment field, counting it in errorLog if it is not a valid int
+bool decodeLabelField(const std::string &field, size_t lineNumber, RowErrorLog &errorLog, int &sentiment)
+{
+    DecodeStatus status = decodeLabel(field, sentiment);
+    if (status == DecodeStatus::Malformed)
+    {
+        errorLog.record(RowErrorLog::MALFORMED_LABEL, lineNumber, field);
+        return false;
+    }
+    if (status == DecodeStatus::OutOfRange)
+    {
+        errorLog.record(RowErrorLog::LABEL_OUT_OF_RANGE, lineNumber, field);
+        return false;
+    }
+    return true;
+}
+
+//decode a tweet ID field, counting it in errorLog if it is not a valid 64-bit ID
+bool decodeIDField(const std::string &field, size_t lineNumber, RowErrorLog &errorLog, uint64_t &tweetID)
+{
+    if (decodeID(field, tweetID) != DecodeStatus::Ok)
+    {
+        errorLog.record(RowErrorLog::MALFORMED_ID, lineNumber, field);
+        return false;
+    }
+    return true;
+}
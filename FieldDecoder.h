@@ -0,0 +1,69 @@
+// FieldDecoder.h
+
+#ifndef FIELDDECODER_H
+#define FIELDDECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//result of decoding a numeric CSV field
+enum class DecodeStatus {
+    Ok,
+    Malformed,  //empty, not a number, or followed by other characters
+    OutOfRange  //a number, but too large for the target type
+};
+
+//decode a label such as "4"; surrounding spaces and a trailing '\r' are ignored. never throws.
+DecodeStatus decodeLabel(const std::string &field, int &out) noexcept;
+
+//decode a 64-bit tweet ID such as "1467811594"; same rules as decodeLabel, except that an ID with
+//leading zeros is Malformed, since it is written back by value and "0007" would come out as "7"
+DecodeStatus decodeID(const std::string &field, uint64_t &out) noexcept;
+
+//counts malformed rows of one input file by category
+//only the first few rows of each category are described individually, and nothing is
+//written until report(), so a dirty feed costs one stderr write instead of one per line
+class RowErrorLog {
+public:
+    enum Category {
+        TOO_FEW_FIELDS,
+        MALFORMED_LABEL,
+        LABEL_OUT_OF_RANGE,
+        INVALID_SENTIMENT, //a number, but not 0 or 4
+        MALFORMED_ID,
+        CATEGORY_COUNT
+    };
+
+    explicit RowErrorLog(const std::string &source, size_t detailLimit = 5);
+
+    //count one bad row; value is the offending field, if any
+    void record(Category category, size_t lineNumber, const std::string &value = "");
+
+    //add the counts (and details, up to the limit) of another log for the same source
+    void merge(const RowErrorLog &other);
+
+    size_t count(Category category) const;
+    size_t total() const;
+
+    //write a summary of the bad rows, if there were any
+    void report(std::ostream &os) const;
+
+private:
+    std::string source;
+    size_t detailLimit;
+    size_t counts[CATEGORY_COUNT];
+    std::vector<std::string> details[CATEGORY_COUNT];
+
+    static const char *categoryName(Category category);
+};
+
+//decode a sentiment field; if it is not a valid int, count it in errorLog and return false
+bool decodeLabelField(const std::string &field, size_t lineNumber, RowErrorLog &errorLog, int &sentiment);
+
+//decode a tweet ID field; if it is not a valid 64-bit ID, count it in errorLog and return false
+bool decodeIDField(const std::string &field, size_t lineNumber, RowErrorLog &errorLog, uint64_t &tweetID);
+
+#endif //FIELDDECODER_H
@@ -2,6 +2,10 @@
 
 #include "SentimentClassifier.h"
 #include "DSString.h"
+#include "CSVIndexer.h"
+#include "TweetTokenizer.h"
+#include "ThreadPool.h"
+#include "FieldDecoder.h"
 #include <vector>
 #include <fstream>
 #include <sstream>
@@ -10,10 +14,27 @@
 #include <algorithm>
 #include <cmath>
 #include <tuple>
+#include <atomic>
+#include <memory>
+#include <functional>
 
 //constructor
-SentimentClassifier::SentimentClassifier() {
-    //initialization if needed
+SentimentClassifier::SentimentClassifier() : decisionThreshold(0.0), fusedTokenizer(false) {
+}
+
+//selects the single-pass TweetTokenizer instead of toLower() + split()
+void SentimentClassifier::setFusedTokenizer(bool enabled) {
+    fusedTokenizer = enabled;
+}
+
+//returns the score cutoff used by predict
+double SentimentClassifier::getThreshold() const {
+    return decisionThreshold;
+}
+
+//sets the score cutoff used by predict
+void SentimentClassifier::setThreshold(double threshold) {
+    decisionThreshold = threshold;
 }
 //helper function to parse a CSV line into fields, handling quotes and commas
 void SentimentClassifier::parseCSVLine(const std::string& line, std::vector<std::string>& fields)
@@ -54,67 +75,110 @@ void SentimentClassifier::parseCSVLine(const std::string& line, std::vector<std:
     fields.push_back(field);
 }
 
+//count one occurrence of word[0..len) in a tweet with the given sentiment
+//only a word seen for the first time is copied into a DSString
+void SentimentClassifier::countWord(const char *word, size_t len, int sentiment)
+{
+    size_t hash = DSString::hashOf(word, len);
+    WordIndex::Entry *entry = wordIndex.find(word, len, hash);
+    if (entry == nullptr)
+    {
+        entry = &*wordFreq.emplace(DSString(word, len), std::make_pair(0, 0)).first;
+        wordIndex.insert(entry);
+    }
+
+    if (sentiment == 4)
+    {
+        entry->second.first++; //increment positive count
+    }
+    else if (sentiment == 0)
+    {
+        entry->second.second++; //increment negative count
+    }
+}
+
+//log-likelihood ratio of word[0..len); words not seen in training score 0
+double SentimentClassifier::wordScore(const char *word, size_t len) const
+{
+    const WordIndex::Entry *entry = wordIndex.find(word, len, DSString::hashOf(word, len));
+    if (entry == nullptr)
+    {
+        return 0.0;
+    }
+    int posCount = entry->second.first;
+    int negCount = entry->second.second;
+    return std::log((posCount + 1.0) / (negCount + 1.0));
+}
+
 //train the classifier using the training data file
 void SentimentClassifier::train(const std::string &trainFile)
 {
-    //open the training data file
-    std::ifstream infile(trainFile);
-    if (!infile.is_open())
+    //read and index the whole training data file
+    std::string buffer;
+    if (!CSVIndexer::loadFile(trainFile, buffer))
     {
         std::cerr << "Error opening training data file: " << trainFile << std::endl;
         return;
     }
+    CSVIndexer csv;
+    csv.index(buffer.data(), buffer.size());
 
-    std::string line;
-    size_t lineNumber = 0; //keep track of the line number for debugging
+    std::string sentimentStr;
+    std::string textStr;
 
-    //skip the header line
-    if (std::getline(infile, line))
+    //skip the header line if present
+    size_t firstRow = 0;
+    if (csv.rowCount() > 0 && csv.fieldCount(0) > 0)
     {
-        lineNumber++;
-        //check if the line contains non-numeric sentiment
-        std::vector<std::string> fields;
-        parseCSVLine(line, fields);
-        if (!fields.empty() && fields[0] == "Sentiment")
+        csv.field(0, 0, sentimentStr);
+        if (sentimentStr == "Sentiment")
         {
-             //skip the header line if present
-        }
-        else
-        {
-            //if no header, reset the stream to the beginning
-            infile.clear();
-            infile.seekg(0, std::ios::beg);
-            lineNumber = 0;
+            firstRow = 1;
         }
     }
 
-    //read each line from the file
-    while (std::getline(infile, line))
+    RowErrorLog errorLog(trainFile);
+
+    //read each row of the file
+    for (size_t row = firstRow; row < csv.rowCount(); ++row)
     {
-        lineNumber++;
-        std::vector<std::string> fields;
-        parseCSVLine(line, fields);
+        size_t lineNumber = row + 1; //keep track of the line number for debugging
 
         //ensure there are at least 6 fields
-        if (fields.size() < 6)
+        if (csv.fieldCount(row) < 6)
         {
-            std::cerr << "Skipping line " << lineNumber << ": Not enough fields." << std::endl;
+            errorLog.record(RowErrorLog::TOO_FEW_FIELDS, lineNumber);
             continue; //skip invalid lines
         }
 
-        //debugging output: Print the contents of fields[0]
-        std::string sentimentStr = fields[0];
-        try
+        csv.field(row, 0, sentimentStr);
+        int sentiment;
+        if (!decodeLabelField(sentimentStr, lineNumber, errorLog, sentiment))
         {
-            int sentiment = std::stoi(sentimentStr);
-            //proceed only if sentiment is 0 or 4
-            if (sentiment != 0 && sentiment != 4)
+            continue;
+        }
+
+        //proceed only if sentiment is 0 or 4
+        if (sentiment != 0 && sentiment != 4)
+        {
+            errorLog.record(RowErrorLog::INVALID_SENTIMENT, lineNumber, sentimentStr);
+            continue;
+        }
+
+        csv.field(row, 5, textStr);
+
+        if (fusedTokenizer)
+        {
+            //normalize and tokenize in one pass, then update word frequencies
+            tokenizer.tokenize(textStr.data(), textStr.size());
+            for (size_t t = 0; t < tokenizer.tokenCount(); ++t)
             {
-                std::cerr << "Skipping line " << lineNumber << ": Invalid sentiment value (" << sentiment << ")." << std::endl;
-                continue;
+                countWord(tokenizer.token(t), tokenizer.tokenLength(t), sentiment);
             }
-
-            DSString tweetText(fields[5].c_str());
+        }
+        else
+        {
+            DSString tweetText(textStr.c_str());
 
             //convert tweet text to lowercase
             tweetText = tweetText.toLower();
@@ -125,43 +189,26 @@ void SentimentClassifier::train(const std::string &trainFile)
             //update word frequencies
             for (const DSString &word : words)
             {
-                if (sentiment == 4)
-                {
-                    wordFreq[word].first++; //increment positive count
-                }
-                else if (sentiment == 0)
-                {
-                    wordFreq[word].second++; //increment negative count
-                }
+                countWord(word.c_str(), word.length(), sentiment);
             }
         }
-        catch (const std::invalid_argument &e)
-        {
-            std::cerr << "Invalid argument on line " << lineNumber << ": Cannot convert sentiment '" << sentimentStr << "' to int." << std::endl;
-            continue;
-        }
-        catch (const std::out_of_range &e)
-        {
-            std::cerr << "Out of range error on line " << lineNumber << ": Sentiment '" << sentimentStr << "' is out of int range." << std::endl;
-            continue;
-        }
     }
 
-    infile.close();
+    errorLog.report(std::cerr);
 }
 
-
-
 //predict sentiments for the test data and write results to resultFile
 void SentimentClassifier::predict(const std::string &testFile, const std::string &resultFile)
 {
-    //open the test data file
-    std::ifstream infile(testFile);
-    if (!infile.is_open())
+    //read and index the whole test data file
+    std::string buffer;
+    if (!CSVIndexer::loadFile(testFile, buffer))
     {
         std::cerr << "Error opening test data file: " << testFile << std::endl;
         return;
     }
+    CSVIndexer csv;
+    csv.index(buffer.data(), buffer.size());
 
     // Open the results file
     std::ofstream outfile(resultFile);
@@ -171,178 +218,214 @@ void SentimentClassifier::predict(const std::string &testFile, const std::string
         return;
     }
 
-    std::string line;
-    size_t lineNumber = 0;
+    //drop predictions from any earlier run
+    predictions.clear();
 
-    //skip the header line if present
-    if (std::getline(infile, line))
+    RowErrorLog errorLog(testFile);
+    scoreRows(csv, testDataStart(csv), csv.rowCount(), tokenizer, predictions, errorLog);
+    errorLog.report(std::cerr);
+
+    //write the predictions to the results file
+    writeResults(predictions, outfile);
+
+    outfile.close();
+}
+
+//first data row of a test file, skipping the header line if present
+size_t SentimentClassifier::testDataStart(const CSVIndexer &csv) const
+{
+    if (csv.rowCount() > 0 && csv.fieldCount(0) > 0)
     {
-        lineNumber++;
-        std::vector<std::string> fields;
-        parseCSVLine(line, fields);
-        if (!fields.empty() && (fields[0] == "TweetID" || fields[0] == "Id" || fields[0] == "id"))
+        std::string first;
+        csv.field(0, 0, first);
+        if (first == "TweetID" || first == "Id" || first == "id")
         {
-            //header line detected and skipped
-        }
-        else
-        {
-            //if no header, reset the stream to the beginning
-            infile.clear();
-            infile.seekg(0, std::ios::beg);
-            lineNumber = 0;
+            return 1;
         }
     }
+    return 0;
+}
+
+//score test rows [firstRow, endRow) and append them to out
+//only reads the model, so several threads may score at once as long as each has its own tokenizer
+void SentimentClassifier::scoreRows(const CSVIndexer &csv, size_t firstRow, size_t endRow, TweetTokenizer &rowTokenizer,
+                                    std::vector<ScoredPrediction> &out, RowErrorLog &errorLog) const
+{
+    std::string idStr;
+    std::string textStr;
+    out.reserve(out.size() + (endRow - firstRow));
 
-    //read each line from the file
-    while (std::getline(infile, line))
+    for (size_t row = firstRow; row < endRow; ++row)
     {
-        lineNumber++;
-        std::vector<std::string> fields;
-        parseCSVLine(line, fields);
+        size_t lineNumber = row + 1;
 
         //ensure there are at least 5 fields (test data has no sentiment column)
-        if (fields.size() < 5)
+        if (csv.fieldCount(row) < 5)
         {
+            errorLog.record(RowErrorLog::TOO_FEW_FIELDS, lineNumber);
             continue; //skip invalid lines
         }
 
         //extract tweet ID and tweet text
-        DSString tweetID(fields[0].c_str());
-        DSString tweetText(fields[4].c_str());
-
-        //convert tweet text to lowercase
-        tweetText = tweetText.toLower();
-
-        //tokenize the tweet
-        std::vector<DSString> words = tweetText.split();
+        csv.field(row, 0, idStr);
+        uint64_t tweetID;
+        if (!decodeIDField(idStr, lineNumber, errorLog, tweetID))
+        {
+            continue;
+        }
+        csv.field(row, 4, textStr);
 
         //compute sentiment score for the tweet
         double tweetScore = 0.0;
-        for (const DSString &word : words)
+        if (fusedTokenizer)
         {
-            auto it = wordFreq.find(word);
-            if (it != wordFreq.end())
+            //normalize and tokenize in one pass
+            rowTokenizer.tokenize(textStr.data(), textStr.size());
+            for (size_t t = 0; t < rowTokenizer.tokenCount(); ++t)
             {
-                int posCount = it->second.first;
-                int negCount = it->second.second;
-                //compute word sentiment score using log-likelihood ratio
-                double wordScore = std::log((posCount + 1.0) / (negCount + 1.0));
-                tweetScore += wordScore;
+                tweetScore += wordScore(rowTokenizer.token(t), rowTokenizer.tokenLength(t));
             }
-            //if word not seen in training, ignore it
         }
+        else
+        {
+            DSString tweetText(textStr.c_str());
 
-        //predict sentiment based on tweet score
-        int predictedSentiment = (tweetScore >= 0) ? 4 : 0;
-
-        //store the prediction
-        predictions[tweetID] = predictedSentiment;
+            //convert tweet text to lowercase
+            tweetText = tweetText.toLower();
 
-        //write the prediction to the results file
-        outfile << predictedSentiment << ", " << tweetID << std::endl;
-    }
+            //tokenize the tweet
+            std::vector<DSString> words = tweetText.split();
 
-    infile.close();
-    outfile.close();
-}
+            for (const DSString &word : words)
+            {
+                tweetScore += wordScore(word.c_str(), word.length());
+            }
+        }
 
+        //predict sentiment based on tweet score
+        int predictedSentiment = (tweetScore >= decisionThreshold) ? 4 : 0;
 
+        //store the prediction along with its raw score for evaluation
+        out.push_back({tweetID, tweetScore, predictedSentiment});
+    }
+}
 
+//write "label, id" lines for each prediction
+void SentimentClassifier::writeResults(const std::vector<ScoredPrediction> &preds, std::ostream &outfile) const
+{
+    for (const ScoredPrediction &pred : preds)
+    {
+        outfile << pred.predicted << ", " << pred.tweetID << '\n';
+    }
+}
 
 //evaluate predictions against the ground truth and write accuracy and errors to accuracyFile
-void SentimentClassifier::evaluatePredictions(const std::string &groundTruthFile, const std::string &accuracyFile)
+void SentimentClassifier::evaluatePredictions(const std::string &groundTruthFile, const std::string &accuracyFile,
+                                              const std::string &sweepFile)
+{
+    std::vector<std::pair<double, bool>> scored;
+    if (evaluate(predictions, groundTruthFile, accuracyFile, scored))
+    {
+        sweepThresholds(scored, sweepFile);
+    }
+}
+
+//compare preds with the ground truth file and write accuracy and errors to accuracyFile
+//scored receives (score, actually positive) for every prediction with a ground truth label
+bool SentimentClassifier::evaluate(const std::vector<ScoredPrediction> &preds, const std::string &groundTruthFile,
+                                   const std::string &accuracyFile, std::vector<std::pair<double, bool>> &scored) const
 {
-    //read ground truth sentiments
-    std::unordered_map<DSString, int> groundTruth;
+    //read ground truth sentiments, each with the index of the last prediction for that tweet ID
+    std::unordered_map<uint64_t, std::pair<int, size_t>> groundTruth;
 
-    std::ifstream infile(groundTruthFile);
-    if (!infile.is_open())
+    std::string buffer;
+    if (!CSVIndexer::loadFile(groundTruthFile, buffer))
     {
         std::cerr << "Error opening ground truth file: " << groundTruthFile << std::endl;
-        return;
+        return false;
     }
+    CSVIndexer csv;
+    csv.index(buffer.data(), buffer.size());
 
-    std::string line;
-    size_t lineNumber = 0;
+    std::string sentimentStr;
+    std::string idStr;
+    RowErrorLog errorLog(groundTruthFile);
 
     //skip the header line if present
-    if (std::getline(infile, line))
+    size_t firstRow = 0;
+    if (csv.rowCount() > 0 && csv.fieldCount(0) > 0)
     {
-        lineNumber++;
-        std::vector<std::string> fields;
-        parseCSVLine(line, fields);
-        if (!fields.empty() && fields[0] == "Sentiment")
+        csv.field(0, 0, sentimentStr);
+        if (sentimentStr == "Sentiment")
         {
-             //skip the header line if present
-        }
-        else
-        {
-            //if no header, reset the stream to the beginning
-            infile.clear();
-            infile.seekg(0, std::ios::beg);
-            lineNumber = 0;
+            firstRow = 1;
         }
     }
 
-    while (std::getline(infile, line))
+    for (size_t row = firstRow; row < csv.rowCount(); ++row)
     {
-        lineNumber++;
-        std::vector<std::string> fields;
-        parseCSVLine(line, fields);
+        size_t lineNumber = row + 1;
 
         //ensure there are at least 2 fields
-        if (fields.size() < 2)
+        if (csv.fieldCount(row) < 2)
         {
-            std::cerr << "Skipping line " << lineNumber << ": Not enough fields." << std::endl;
+            errorLog.record(RowErrorLog::TOO_FEW_FIELDS, lineNumber);
             continue; //skip invalid lines
         }
 
-        std::string sentimentStr = fields[0];
-        try
+        csv.field(row, 0, sentimentStr);
+        int actualSentiment;
+        if (!decodeLabelField(sentimentStr, lineNumber, errorLog, actualSentiment))
         {
-            int actualSentiment = std::stoi(sentimentStr);
-
-            DSString tweetID(fields[1].c_str());
-
-            groundTruth[tweetID] = actualSentiment;
-        }
-        catch (const std::invalid_argument &e)
-        {
-            std::cerr << "Invalid argument on line " << lineNumber << ": Cannot convert sentiment '" << sentimentStr << "' to int." << std::endl;
             continue;
         }
-        catch (const std::out_of_range &e)
+
+        csv.field(row, 1, idStr);
+        uint64_t tweetID;
+        if (!decodeIDField(idStr, lineNumber, errorLog, tweetID))
         {
-            std::cerr << "Out of range error on line " << lineNumber << ": Sentiment '" << sentimentStr << "' is out of int range." << std::endl;
             continue;
         }
+
+        groundTruth[tweetID] = std::make_pair(actualSentiment, preds.size());
     }
 
-    infile.close();
+    errorLog.report(std::cerr);
+
+    //a tweet ID listed more than once in the test file is evaluated once, using its last prediction
+    for (size_t i = 0; i < preds.size(); ++i)
+    {
+        auto it = groundTruth.find(preds[i].tweetID);
+        if (it != groundTruth.end())
+        {
+            it->second.second = i;
+        }
+    }
 
     //compare predictions to ground truth
     int correct = 0;
     int total = 0;
-    std::vector<std::tuple<int, int, DSString>> errors; // (predicted, actual, tweetID)
+    std::vector<std::tuple<int, int, uint64_t>> errors; // (predicted, actual, tweetID)
+    scored.clear();
+    scored.reserve(preds.size());
 
-    for (const auto &pred : predictions)
+    for (size_t i = 0; i < preds.size(); ++i)
     {
-        DSString tweetID = pred.first;
-        int predictedSentiment = pred.second;
-
-        auto it = groundTruth.find(tweetID);
-        if (it != groundTruth.end())
+        const ScoredPrediction &pred = preds[i];
+        auto it = groundTruth.find(pred.tweetID);
+        if (it != groundTruth.end() && it->second.second == i)
         {
-            int actualSentiment = it->second;
-            if (predictedSentiment == actualSentiment)
+            int actualSentiment = it->second.first;
+            if (pred.predicted == actualSentiment)
             {
                 correct++;
             }
             else
             {
                 //store errors
-                errors.emplace_back(predictedSentiment, actualSentiment, tweetID);
+                errors.emplace_back(pred.predicted, actualSentiment, pred.tweetID);
             }
+            scored.emplace_back(pred.score, actualSentiment == 4);
             total++;
         }
     }
@@ -355,7 +438,7 @@ void SentimentClassifier::evaluatePredictions(const std::string &groundTruthFile
     if (!outfile.is_open())
     {
         std::cerr << "Error opening accuracy file: " << accuracyFile << std::endl;
-        return;
+        return false;
     }
 
     outfile << std::fixed;
@@ -366,12 +449,243 @@ void SentimentClassifier::evaluatePredictions(const std::string &groundTruthFile
     {
         int predicted = std::get<0>(err);
         int actual = std::get<1>(err);
-        DSString tweetID = std::get<2>(err);
+        uint64_t tweetID = std::get<2>(err);
 
-        outfile << predicted << ", " << actual << ", " << tweetID << std::endl;
+        outfile << predicted << ", " << actual << ", " << tweetID << '\n';
     }
 
     outfile.close();
+    return true;
+}
+
+//score many test files against this model on a work-stealing pool
+//each file is loaded and indexed by one task, then split into chunks of rows that any worker may steal;
+//whichever worker finishes a file's last chunk writes that file's results and accuracy, frees its memory
+//and starts loading the next file, so only a few files are held in memory at any time
+size_t SentimentClassifier::predictBatch(const std::vector<BatchJob> &jobs, size_t threads) const
+{
+    struct FileState
+    {
+        const BatchJob *job;
+        std::string buffer;
+        CSVIndexer csv;
+        std::vector<std::vector<ScoredPrediction>> chunks;
+        std::vector<RowErrorLog> chunkErrors;
+        std::atomic<size_t> chunksLeft;
+    };
+
+    std::vector<std::unique_ptr<FileState>> files;
+    for (const BatchJob &job : jobs)
+    {
+        files.push_back(std::unique_ptr<FileState>(new FileState()));
+        files.back()->job = &job;
+    }
+
+    ThreadPool pool(threads);
+    std::vector<TweetTokenizer> tokenizers(pool.size()); //one per worker
+    std::atomic<size_t> nextFile(0);
+    std::atomic<size_t> failed(0);
+    std::function<void()> loadNextFile;
+
+    //write the results (and accuracy, if there is ground truth) of a fully scored file, then free it
+    auto finishFile = [this, &loadNextFile, &failed](FileState &file)
+    {
+        std::vector<ScoredPrediction> preds;
+        for (std::vector<ScoredPrediction> &chunk : file.chunks)
+        {
+            preds.insert(preds.end(), chunk.begin(), chunk.end());
+        }
+
+        //clear() would keep the capacity; swapping with empty objects gives the memory back
+        std::vector<std::vector<ScoredPrediction>>().swap(file.chunks);
+        std::string().swap(file.buffer);
+        file.csv = CSVIndexer();
+
+        RowErrorLog errorLog(file.job->testFile);
+        for (const RowErrorLog &chunkLog : file.chunkErrors)
+        {
+            errorLog.merge(chunkLog);
+        }
+        std::vector<RowErrorLog>().swap(file.chunkErrors);
+        errorLog.report(std::cerr);
+
+        std::ofstream outfile(file.job->resultFile);
+        if (!outfile.is_open())
+        {
+            std::cerr << "Error opening results file: " << file.job->resultFile << std::endl;
+            failed++;
+        }
+        else
+        {
+            writeResults(preds, outfile);
+            outfile.close();
+
+            std::vector<std::pair<double, bool>> scored;
+            if (!file.job->groundTruthFile.empty() &&
+                !evaluate(preds, file.job->groundTruthFile, file.job->accuracyFile, scored))
+            {
+                failed++;
+            }
+        }
+
+        loadNextFile();
+    };
+
+    //queue the loading of the next file that has not been started, if any
+    loadNextFile = [this, &files, &nextFile, &failed, &pool, &tokenizers, &loadNextFile, finishFile]()
+    {
+        size_t next = nextFile++;
+        if (next >= files.size())
+        {
+            return;
+        }
+        FileState *file = files[next].get();
+        pool.submit([this, file, &failed, &pool, &tokenizers, &loadNextFile, finishFile](size_t)
+        {
+            if (!CSVIndexer::loadFile(file->job->testFile, file->buffer))
+            {
+                std::cerr << "Error opening test data file: " << file->job->testFile << std::endl;
+                failed++;
+                loadNextFile();
+                return;
+            }
+            file->csv.index(file->buffer.data(), file->buffer.size());
+
+            size_t firstRow = testDataStart(file->csv);
+            size_t rows = file->csv.rowCount() - firstRow;
+            size_t chunkCount = (rows + BATCH_CHUNK_ROWS - 1) / BATCH_CHUNK_ROWS;
+            if (chunkCount == 0)
+            {
+                chunkCount = 1;
+            }
+            file->chunks.resize(chunkCount);
+            file->chunkErrors.assign(chunkCount, RowErrorLog(file->job->testFile));
+            file->chunksLeft = chunkCount;
+
+            for (size_t c = 0; c < chunkCount; ++c)
+            {
+                size_t begin = firstRow + c * BATCH_CHUNK_ROWS;
+                size_t end = std::min(begin + BATCH_CHUNK_ROWS, file->csv.rowCount());
+                pool.submit([this, file, begin, end, c, &tokenizers, finishFile](size_t worker)
+                {
+                    scoreRows(file->csv, begin, end, tokenizers[worker], file->chunks[c], file->chunkErrors[c]);
+                    if (--file->chunksLeft == 0)
+                    {
+                        finishFile(*file);
+                    }
+                });
+            }
+        });
+    };
+
+    for (size_t i = 0; i < pool.size() * BATCH_FILES_PER_THREAD; ++i)
+    {
+        loadNextFile();
+    }
+
+    pool.wait();
+    return failed;
+}
+
+//sort the scored predictions once and compute accuracy, precision, recall and F1 at every
+//distinct threshold plus the ROC-AUC; the most accurate threshold becomes the decision threshold
+void SentimentClassifier::sweepThresholds(std::vector<std::pair<double, bool>> &scored, const std::string &sweepFile)
+{
+    if (scored.empty())
+    {
+        return;
+    }
+
+    //highest score first, so lowering the threshold moves one run of equal scores at a time to positive
+    std::sort(scored.begin(), scored.end(),
+              [](const std::pair<double, bool> &a, const std::pair<double, bool> &b) { return a.first > b.first; });
+
+    long long positives = 0;
+    for (const auto &s : scored)
+    {
+        if (s.second)
+        {
+            positives++;
+        }
+    }
+    long long negatives = static_cast<long long>(scored.size()) - positives;
+    double n = static_cast<double>(scored.size());
+
+    std::ofstream outfile;
+    if (!sweepFile.empty())
+    {
+        outfile.open(sweepFile);
+        if (!outfile.is_open())
+        {
+            std::cerr << "Error opening threshold sweep file: " << sweepFile << std::endl;
+        }
+    }
+
+    std::ostringstream rows;
+    rows << std::fixed;
+    rows.precision(4);
+
+    //the ROC curve starts from everything predicted negative; the best threshold is picked
+    //among the real distinct scores, the highest one winning a tie
+    long long tp = 0;
+    long long fp = 0;
+    double bestThreshold = scored.front().first;
+    double bestAccuracy = -1.0;
+    double auc = 0.0;
+    double prevTpr = 0.0;
+    double prevFpr = 0.0;
+
+    size_t i = 0;
+    while (i < scored.size())
+    {
+        //consume every prediction sharing this score
+        double threshold = scored[i].first;
+        while (i < scored.size() && scored[i].first == threshold)
+        {
+            if (scored[i].second)
+            {
+                tp++;
+            }
+            else
+            {
+                fp++;
+            }
+            ++i;
+        }
+
+        double accuracy = (tp + (negatives - fp)) / n;
+        double precision = static_cast<double>(tp) / (tp + fp);
+        double recall = (positives > 0) ? static_cast<double>(tp) / positives : 0.0;
+        double f1 = (precision + recall > 0) ? 2 * precision * recall / (precision + recall) : 0.0;
+
+        //trapezoid between this ROC point and the previous one
+        double tpr = recall;
+        double fpr = (negatives > 0) ? static_cast<double>(fp) / negatives : 0.0;
+        auc += (fpr - prevFpr) * (tpr + prevTpr) / 2.0;
+        prevTpr = tpr;
+        prevFpr = fpr;
+
+        if (accuracy > bestAccuracy)
+        {
+            bestAccuracy = accuracy;
+            bestThreshold = threshold;
+        }
+
+        rows << threshold << ", " << accuracy << ", " << precision << ", " << recall << ", " << f1 << "\n";
+    }
+
+    decisionThreshold = bestThreshold;
+
+    if (outfile.is_open())
+    {
+        outfile << std::fixed;
+        outfile.precision(4);
+        outfile << "roc_auc, " << auc << "\n";
+        outfile << "best_threshold, " << bestThreshold << ", " << bestAccuracy << "\n";
+        outfile << "threshold, accuracy, precision, recall, f1\n";
+        outfile << rows.str();
+        outfile.close();
+    }
 }
 
 void SentimentClassifier::testParseCSVLine()
@@ -387,3 +701,138 @@ void SentimentClassifier::testParseCSVLine()
     }
 }
 
+//differential test: the block indexer must split every row of buffer exactly like parseCSVLine
+bool SentimentClassifier::compareCSVIndexer(const std::string &buffer, const std::string &name)
+{
+    CSVIndexer csv;
+    csv.index(buffer.data(), buffer.size());
+
+    std::istringstream lines(buffer);
+    std::string line;
+    std::vector<std::string> expected;
+    std::vector<std::string> actual;
+    size_t row = 0;
+
+    while (std::getline(lines, line))
+    {
+        parseCSVLine(line, expected);
+        if (row >= csv.rowCount())
+        {
+            std::cout << name << ": indexer found only " << csv.rowCount() << " rows" << std::endl;
+            return false;
+        }
+        csv.fields(row, actual);
+        if (actual != expected)
+        {
+            std::cout << name << ": row " << row + 1 << " differs" << std::endl;
+            return false;
+        }
+        ++row;
+    }
+
+    if (row != csv.rowCount())
+    {
+        std::cout << name << ": indexer found " << csv.rowCount() << " rows, expected " << row << std::endl;
+        return false;
+    }
+
+    std::cout << name << ": " << row << " rows match" << std::endl;
+    return true;
+}
+
+//compare the block indexer against parseCSVLine on a CSV file
+bool SentimentClassifier::testCSVIndexer(const std::string &csvFile)
+{
+    std::string buffer;
+    if (!CSVIndexer::loadFile(csvFile, buffer))
+    {
+        std::cerr << "Error opening CSV file: " << csvFile << std::endl;
+        return false;
+    }
+    return compareCSVIndexer(buffer, csvFile);
+}
+
+//compare the block indexer against parseCSVLine on hand-written edge cases
+bool SentimentClassifier::testCSVIndexer()
+{
+    std::string buffer =
+        "4,1467811594,Mon Apr 06 22:20:03 PDT 2009,NO_QUERY,peruna_pony,\"Beat TCU\"\n"
+        "\n"
+        ",,,\n"
+        "0,1,\"she said \"\"hi\"\", then left\",\"\"\"\"\"\",x\"\"y\n"
+        "0,2,\"a quoted field long enough to cross the 64-byte block boundary, with commas, inside\",end\n"
+        "1,Mon,NO_QUERY,bob,he is 5\" tall\n"
+        "0,4,\"a quoted field that is broken\nacross two lines\",end\n"
+        "0,5,a stray quote \" near the end of one 64-byte block, with, commas, after it\n"
+        "0,6,the next row must still split normally\n"
+        "4,3,no trailing newline";
+    return compareCSVIndexer(buffer, "edge cases");
+}
+
+//check the single-pass tokenizer against hand-written cases and their expected tokens
+bool SentimentClassifier::testTweetTokenizer()
+{
+    const std::vector<std::pair<std::string, std::vector<std::string>>> cases = {
+        //plain text splits like toLower() + split()
+        {"Beat TCU!", {"beat", "tcu"}},
+        {"  don't   stop...now ", {"don", "t", "stop", "now"}},
+        {"", {}},
+        {"!!!", {}},
+        //named and decimal entities decode before splitting
+        {"Tom &amp; Jerry", {"tom", "jerry"}},
+        {"a&lt;b&gt;c", {"a", "b", "c"}},
+        {"&quot;hi&quot; it&apos;s", {"hi", "it", "s"}},
+        {"don&#39;t", {"don", "t"}},
+        {"&#65;BC", {"abc"}},
+        {"&AMP;co", {"co"}},
+        //unknown, unterminated and out-of-range entities are left as text
+        {"&foo;bar", {"foo", "bar"}},
+        {"fish &amp chips", {"fish", "amp", "chips"}},
+        {"&#128;x", {"128", "x"}},
+        {"&#;", {}},
+        //control characters end the token
+        {"&#0;abc", {"abc"}},
+        {"a&#1;b", {"a", "b"}},
+        //URLs fold to <url> up to the next whitespace
+        {"see http://t.co/abc, now", {"see", "<url>", "now"}},
+        {"HTTPS://Example.com/x?y=1", {"<url>"}},
+        {"go www.site.com.", {"go", "<url>"}},
+        {"xhttp://a", {"xhttp", "a"}},
+        {"http:/x", {"http", "x"}},
+        //@mentions fold to <user> at the start of a token only
+        {"@Bob_1! hi", {"<user>", "hi"}},
+        {"thanks @alice@bob", {"thanks", "<user>", "<user>"}},
+        {"mail me@home", {"mail", "me", "home"}},
+        {"@ alone", {"alone"}},
+        {"(@bob)", {"<user>"}},
+    };
+
+    TweetTokenizer caseTokenizer;
+    std::vector<std::string> actual;
+    bool ok = true;
+    for (const auto &c : cases)
+    {
+        caseTokenizer.tokenize(c.first.data(), c.first.size());
+        actual.clear();
+        for (size_t t = 0; t < caseTokenizer.tokenCount(); ++t)
+        {
+            actual.emplace_back(caseTokenizer.token(t), caseTokenizer.tokenLength(t));
+        }
+        if (actual != c.second)
+        {
+            std::cout << "tokenizer: \"" << c.first << "\" gives";
+            for (const std::string &token : actual)
+            {
+                std::cout << " [" << token << "]";
+            }
+            std::cout << std::endl;
+            ok = false;
+        }
+    }
+
+    if (ok)
+    {
+        std::cout << "tokenizer: " << cases.size() << " cases match" << std::endl;
+    }
+    return ok;
+}
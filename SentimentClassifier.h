@@ -4,25 +4,80 @@
 #define SENTIMENTCLASSIFIER_H
 
 #include "DSString.h"
+#include "CSVIndexer.h"
+#include "TweetTokenizer.h"
+#include "WordIndex.h"
+#include "FieldDecoder.h"
+#include <cstdint>
+#include <ostream>
 #include <unordered_map>
 #include <vector>
 #include <string>
 
+//one test file of a batch run and where its output goes
+struct BatchJob {
+    std::string testFile;
+    std::string groundTruthFile; //empty if there is no ground truth; then no accuracy file is written
+    std::string resultFile;
+    std::string accuracyFile;
+};
+
 class SentimentClassifier {
 private:
+    //rows per task when a batch splits a large test file
+    static const size_t BATCH_CHUNK_ROWS = 2048;
+
+    //files a batch keeps loaded at once, per thread; the next file is read when one is written
+    static const size_t BATCH_FILES_PER_THREAD = 2;
+
     //map to store word frequencies in positive and negative tweets
     //key: word (DSString), Value: pair<positive count, negative count>
     std::unordered_map<DSString, std::pair<int, int>> wordFreq;
 
-    //map to store predictions
-    //key: tweet ID (DSString), Value: predicted sentiment (int)
-    std::unordered_map<DSString, int> predictions;
+    //index over wordFreq's entries so tokens can be looked up without building a DSString
+    WordIndex wordIndex;
+
+    //a single prediction: tweet ID, raw log-likelihood score and the label it was given
+    struct ScoredPrediction {
+        uint64_t tweetID;
+        double score;
+        int predicted;
+    };
+
+    //predictions in the order they were read from the test file
+    //a repeated tweet ID keeps every row here and in the results file, but is evaluated once by its last row
+    std::vector<ScoredPrediction> predictions;
+
+    //tweets scoring at or above this cutoff are labelled positive (4)
+    double decisionThreshold;
+
+    //tokenize with the single-pass TweetTokenizer instead of toLower() + split()
+    //must be the same for train and predict, since it changes the vocabulary
+    bool fusedTokenizer;
+    TweetTokenizer tokenizer; //reused between tweets to avoid reallocating its buffer
+
+    void countWord(const char* word, size_t len, int sentiment);
+    double wordScore(const char* word, size_t len) const;
+
+    size_t testDataStart(const CSVIndexer& csv) const;
+    void scoreRows(const CSVIndexer& csv, size_t firstRow, size_t endRow, TweetTokenizer& rowTokenizer,
+                   std::vector<ScoredPrediction>& out, RowErrorLog& errorLog) const;
+    void writeResults(const std::vector<ScoredPrediction>& preds, std::ostream& outfile) const;
+    bool evaluate(const std::vector<ScoredPrediction>& preds, const std::string& groundTruthFile,
+                  const std::string& accuracyFile, std::vector<std::pair<double, bool>>& scored) const;
+
     void parseCSVLine(const std::string& line, std::vector<std::string>& fields);
+    bool compareCSVIndexer(const std::string& buffer, const std::string& name);
+    void sweepThresholds(std::vector<std::pair<double, bool>>& scored, const std::string& sweepFile);
 
 public:
     //constructor
     SentimentClassifier();
 
+    //not copyable: wordIndex points into this object's wordFreq
+    SentimentClassifier(const SentimentClassifier&) = delete;
+    SentimentClassifier& operator=(const SentimentClassifier&) = delete;
+
     //train the classifier using the training data file
     void train(const std::string& trainFile);
 
@@ -30,8 +85,26 @@ public:
     void predict(const std::string& testFile, const std::string& resultFile);
 
     //evaluate predictions against the ground truth and write accuracy and errors to accuracyFile
-    void evaluatePredictions(const std::string& groundTruthFile, const std::string& accuracyFile);
+    //if sweepFile is given, also write accuracy/precision/recall/F1 at every threshold and the ROC-AUC to it;
+    //the threshold with the best accuracy is stored as the new decision threshold
+    void evaluatePredictions(const std::string& groundTruthFile, const std::string& accuracyFile,
+                             const std::string& sweepFile = "");
+
+    //predict every job with this (already trained) model using a pool of threads
+    //each job gets its own results file, and an accuracy file if it has ground truth
+    //returns the number of jobs that failed: unreadable test or ground truth file, or an output that cannot be written
+    size_t predictBatch(const std::vector<BatchJob>& jobs, size_t threads) const;
+
+    //use the single-pass tokenizer (lowercasing, entity decoding, URL/@mention folding) in train and predict
+    void setFusedTokenizer(bool enabled);
+
+    //get/set the score cutoff used by predict
+    double getThreshold() const;
+    void setThreshold(double threshold);
     void testParseCSVLine();
+    bool testCSVIndexer();
+    bool testCSVIndexer(const std::string& csvFile);
+    bool testTweetTokenizer();
 };
 
 #endif //SENTIMENTCLASSIFIER_H
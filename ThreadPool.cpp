@@ -0,0 +1,134 @@
+// ThreadPool.cpp
+
+#include "ThreadPool.h"
+
+namespace
+{
+    //the pool and worker index of the current thread, if it is a pool worker
+    thread_local const ThreadPool *currentPool = nullptr;
+    thread_local size_t currentWorker = 0;
+}
+
+//constructor: start the workers
+ThreadPool::ThreadPool(size_t threads) : queued(0), pending(0), nextQueue(0), stopping(false)
+{
+    if (threads == 0)
+    {
+        threads = 1;
+    }
+    for (size_t i = 0; i < threads; ++i)
+    {
+        queues.push_back(std::unique_ptr<Queue>(new Queue()));
+    }
+    for (size_t i = 0; i < threads; ++i)
+    {
+        workers.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+//destructor: finish outstanding work and join the workers
+ThreadPool::~ThreadPool()
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> guard(idleLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+//queue a task
+void ThreadPool::submit(Task task)
+{
+    size_t target = (currentPool == this) ? currentWorker : nextQueue++ % queues.size();
+
+    pending++;
+    {
+        std::lock_guard<std::mutex> guard(queues[target]->lock);
+        queues[target]->tasks.push_back(std::move(task));
+        queued++;
+    }
+
+    //take the lock so a worker cannot miss the wakeup between checking queued and sleeping
+    {
+        std::lock_guard<std::mutex> guard(idleLock);
+    }
+    wake.notify_one();
+}
+
+//wait for all tasks to finish
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> guard(idleLock);
+    done.wait(guard, [this] { return pending == 0; });
+}
+
+//number of worker threads
+size_t ThreadPool::size() const
+{
+    return workers.size();
+}
+
+//take a task from our own deque (newest first) or steal one from another (oldest first)
+bool ThreadPool::tryPop(size_t self, Task &task)
+{
+    {
+        Queue &own = *queues[self];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < queues.size(); ++i)
+    {
+        Queue &victim = *queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+//worker loop
+void ThreadPool::run(size_t self)
+{
+    currentPool = this;
+    currentWorker = self;
+
+    Task task;
+    while (true)
+    {
+        if (tryPop(self, task))
+        {
+            task(self);
+            task = nullptr;
+            if (--pending == 0)
+            {
+                std::lock_guard<std::mutex> guard(idleLock);
+                done.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(idleLock);
+        wake.wait(guard, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0)
+        {
+            return;
+        }
+    }
+}
@@ -0,0 +1,60 @@
+// ThreadPool.h
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//work-stealing thread pool
+//every worker owns a deque: it pushes and pops its own tasks at the back and, when it runs dry,
+//steals from the front of the other workers' deques. tasks may submit more tasks.
+class ThreadPool {
+public:
+    //a task receives the index of the worker running it, so it can use per-worker scratch space
+    using Task = std::function<void(size_t worker)>;
+
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    //queue a task; from a worker it goes on that worker's own deque
+    void submit(Task task);
+
+    //block until every submitted task, including ones submitted by tasks, has finished
+    void wait();
+
+    //number of worker threads
+    size_t size() const;
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex idleLock;
+    std::condition_variable wake; //signalled when a task is queued or the pool stops
+    std::condition_variable done; //signalled when pending drops to zero
+    std::atomic<size_t> queued;   //tasks sitting in a deque
+    std::atomic<size_t> pending;  //tasks submitted but not finished
+    std::atomic<size_t> nextQueue; //round robin for tasks submitted from outside the pool
+    bool stopping;
+
+    bool tryPop(size_t self, Task &task);
+    void run(size_t self);
+};
+
+#endif //THREADPOOL_H
@@ -0,0 +1,193 @@
+// TweetTokenizer.cpp
+
+#include "TweetTokenizer.h"
+#include <cctype>
+#include <cstring>
+
+const char *const TweetTokenizer::URL_TOKEN = "<url>";
+const char *const TweetTokenizer::USER_TOKEN = "<user>";
+
+namespace
+{
+    //per-byte lowercase mapping and delimiter flag, same rules as toLower() and split()
+    struct CharTable
+    {
+        unsigned char lower[256];
+        bool delimiter[256];
+
+        CharTable()
+        {
+            for (int c = 0; c < 256; ++c)
+            {
+                lower[c] = static_cast<unsigned char>(std::tolower(c));
+                delimiter[c] = std::isspace(c) || std::ispunct(c);
+            }
+        }
+    };
+
+    const CharTable table;
+
+    //true if text[i..len) starts with prefix, ignoring case
+    bool startsWith(const char *text, size_t i, size_t len, const char *prefix)
+    {
+        for (; *prefix; ++prefix, ++i)
+        {
+            if (i >= len || table.lower[static_cast<unsigned char>(text[i])] != *prefix)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool isHandleChar(unsigned char c)
+    {
+        return std::isalnum(c) || c == '_';
+    }
+
+    //decode the HTML entity starting at text[i] == '&'
+    //returns the number of bytes consumed, or 0 if this is not a known entity
+    size_t decodeEntity(const char *text, size_t i, size_t len, unsigned char &out)
+    {
+        static const struct
+        {
+            const char *name;
+            unsigned char value;
+        } named[] = {{"&amp;", '&'}, {"&lt;", '<'}, {"&gt;", '>'}, {"&quot;", '"'}, {"&apos;", '\''}};
+
+        for (const auto &entity : named)
+        {
+            if (startsWith(text, i, len, entity.name))
+            {
+                out = entity.value;
+                return std::strlen(entity.name);
+            }
+        }
+
+        //decimal character reference in the ASCII range, e.g. &#39;
+        //a control character (&#0; and the like) decodes to a space, so it ends the token instead of joining it
+        if (i + 2 < len && text[i + 1] == '#')
+        {
+            size_t j = i + 2;
+            unsigned value = 0;
+            while (j < len && j < i + 5 && std::isdigit(static_cast<unsigned char>(text[j])))
+            {
+                value = value * 10 + (text[j] - '0');
+                ++j;
+            }
+            if (j > i + 2 && j < len && text[j] == ';' && value < 128)
+            {
+                out = std::iscntrl(static_cast<int>(value)) ? ' ' : static_cast<unsigned char>(value);
+                return j + 1 - i;
+            }
+        }
+        return 0;
+    }
+}
+
+//terminate the token that began at start, or drop it if it is empty
+void TweetTokenizer::endToken(size_t start)
+{
+    if (tokenData.size() > start)
+    {
+        tokenData.push_back('\0');
+        tokenStarts.push_back(start);
+    }
+}
+
+//append a whole token
+void TweetTokenizer::addToken(const char *token, size_t len)
+{
+    tokenStarts.push_back(tokenData.size());
+    tokenData.insert(tokenData.end(), token, token + len);
+    tokenData.push_back('\0');
+}
+
+//tokenize a tweet in one pass
+void TweetTokenizer::tokenize(const char *text, size_t len)
+{
+    tokenData.clear();
+    tokenStarts.clear();
+
+    size_t start = 0;       //where the current token begins in tokenData
+    bool atBoundary = true; //previous input byte ended a token (or this is the first byte)
+    size_t i = 0;
+
+    while (i < len)
+    {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+
+        if (atBoundary)
+        {
+            //fold URLs into a single placeholder, up to the next whitespace
+            if ((c == 'h' || c == 'H' || c == 'w' || c == 'W') &&
+                (startsWith(text, i, len, "http://") || startsWith(text, i, len, "https://") ||
+                 startsWith(text, i, len, "www.")))
+            {
+                while (i < len && !std::isspace(static_cast<unsigned char>(text[i])))
+                {
+                    ++i;
+                }
+                addToken(URL_TOKEN, std::strlen(URL_TOKEN));
+                start = tokenData.size();
+                continue;
+            }
+
+            //fold @mentions into a single placeholder
+            if (c == '@' && i + 1 < len && isHandleChar(static_cast<unsigned char>(text[i + 1])))
+            {
+                ++i;
+                while (i < len && isHandleChar(static_cast<unsigned char>(text[i])))
+                {
+                    ++i;
+                }
+                addToken(USER_TOKEN, std::strlen(USER_TOKEN));
+                start = tokenData.size();
+                continue;
+            }
+        }
+
+        size_t consumed = 1;
+        if (c == '&')
+        {
+            size_t n = decodeEntity(text, i, len, c);
+            if (n > 0)
+            {
+                consumed = n;
+            }
+        }
+        i += consumed;
+
+        if (table.delimiter[c])
+        {
+            endToken(start);
+            start = tokenData.size();
+            atBoundary = true;
+        }
+        else
+        {
+            tokenData.push_back(static_cast<char>(table.lower[c]));
+            atBoundary = false;
+        }
+    }
+    endToken(start);
+}
+
+//number of tokens found
+size_t TweetTokenizer::tokenCount() const
+{
+    return tokenStarts.size();
+}
+
+//the i-th token as a C-string
+const char *TweetTokenizer::token(size_t i) const
+{
+    return tokenData.data() + tokenStarts[i];
+}
+
+//length of the i-th token
+size_t TweetTokenizer::tokenLength(size_t i) const
+{
+    size_t end = (i + 1 < tokenStarts.size()) ? tokenStarts[i + 1] : tokenData.size();
+    return end - tokenStarts[i] - 1;
+}
@@ -0,0 +1,35 @@
+// TweetTokenizer.h
+
+#ifndef TWEETTOKENIZER_H
+#define TWEETTOKENIZER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//single-pass tweet normalizer and tokenizer
+//lowercasing, HTML entity decoding (&amp; &lt; &gt; &quot; &apos; &#NN;), URL and @mention
+//folding and token boundary detection all happen in one walk over the input bytes.
+//tokens are written back to back into a buffer that is reused between tweets.
+class TweetTokenizer {
+private:
+    std::vector<char> tokenData;     //every token followed by a '\0'
+    std::vector<size_t> tokenStarts; //offset of each token in tokenData
+
+    void endToken(size_t start);
+    void addToken(const char *token, size_t len);
+
+public:
+    //placeholder tokens; they contain punctuation so split() can never produce them
+    static const char *const URL_TOKEN;
+    static const char *const USER_TOKEN;
+
+    //tokenize text[0..len), replacing the tokens of the previous call
+    void tokenize(const char *text, size_t len);
+
+    size_t tokenCount() const;          //number of tokens found
+    const char *token(size_t i) const;  //the i-th token as a C-string
+    size_t tokenLength(size_t i) const; //length of the i-th token
+};
+
+#endif //TWEETTOKENIZER_H
@@ -0,0 +1,60 @@
+// WordIndex.cpp
+
+#include "WordIndex.h"
+#include <cstring>
+
+//constructor
+WordIndex::WordIndex() : slots(1024, nullptr), used(0)
+{
+}
+
+//linear probing from the hash's home slot
+WordIndex::Entry *WordIndex::find(const char *word, size_t len, size_t hash) const
+{
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        Entry *entry = slots[i];
+        if (entry == nullptr)
+        {
+            return nullptr;
+        }
+        const DSString &key = entry->first;
+        if (key.hash() == hash && key.length() == len && std::memcmp(key.c_str(), word, len) == 0)
+        {
+            return entry;
+        }
+    }
+}
+
+//add an entry, keeping the table at most half full
+void WordIndex::insert(Entry *entry)
+{
+    if (2 * (used + 1) > slots.size())
+    {
+        grow();
+    }
+    size_t mask = slots.size() - 1;
+    size_t i = entry->first.hash() & mask; //also caches the key's hash, see WordIndex.h
+    while (slots[i] != nullptr)
+    {
+        i = (i + 1) & mask;
+    }
+    slots[i] = entry;
+    used++;
+}
+
+//double the table and re-place every entry
+void WordIndex::grow()
+{
+    std::vector<Entry *> old(slots.size() * 2, nullptr);
+    old.swap(slots);
+    used = 0;
+    for (Entry *entry : old)
+    {
+        if (entry != nullptr)
+        {
+            insert(entry);
+        }
+    }
+}
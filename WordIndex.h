@@ -0,0 +1,36 @@
+// WordIndex.h
+
+#ifndef WORDINDEX_H
+#define WORDINDEX_H
+
+#include "DSString.h"
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+//open-addressing index over the entries of the classifier's word map
+//lookups take the word's bytes and precomputed hash, so a token sitting in a reusable buffer
+//can be found without building a DSString for it. entries are pointers into the map, whose
+//nodes never move, so the index stays valid while the map grows.
+//insert() hashes each key, so once training is done find() only reads the keys and may be
+//called from several threads at once.
+class WordIndex {
+public:
+    using Entry = std::pair<const DSString, std::pair<int, int>>;
+
+    WordIndex();
+
+    //the entry for word[0..len) with hash DSString::hashOf(word, len), or nullptr
+    Entry *find(const char *word, size_t len, size_t hash) const;
+
+    //add an entry that is not in the index yet
+    void insert(Entry *entry);
+
+private:
+    std::vector<Entry *> slots; //power-of-two sized, nullptr marks an empty slot
+    size_t used;
+
+    void grow();
+};
+
+#endif //WORDINDEX_H
@@ -1,16 +1,282 @@
 // main.cpp
 /*
-Compiling: g++ -std=c++17 -o sentiment main.cpp SentimentClassifier.cpp DSString.cpp
+Compiling: g++ -std=c++17 -O2 -march=native -o sentiment main.cpp SentimentClassifier.cpp DSString.cpp CSVIndexer.cpp TweetTokenizer.cpp WordIndex.cpp ThreadPool.cpp FieldDecoder.cpp -pthread
 ./sentiment data/train_dataset_20k.csv data/test_dataset_10k.csv data/test_dataset_sentiment_10k.csv output
+./sentiment --fused data/train_dataset_20k.csv data/test_dataset_10k.csv data/test_dataset_sentiment_10k.csv output
+./sentiment --batch data/train_dataset_20k.csv output_dir manifest.txt "hourly/tweets_*.csv"
+./sentiment --test-csv data/train_dataset_20k.csv data/test_dataset_10k.csv data/test_dataset_sentiment_10k.csv
+./sentiment --test-tokenizer
 */
 #include "SentimentClassifier.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+//true if name matches pattern, where '*' matches any run of characters and '?' any one character
+static bool wildcardMatch(const std::string &pattern, const std::string &name) {
+    size_t p = 0, n = 0;
+    size_t star = std::string::npos, resume = 0;
+    while (n < name.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            ++p;
+            ++n;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            resume = n;
+        } else if (star != std::string::npos) {
+            p = star + 1;
+            n = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+//true if file has a .csv extension, in any case
+static bool isCSVFile(const fs::path &file) {
+    std::string ext = file.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    return ext == ".csv";
+}
+
+//a manifest entry as a path: relative entries are relative to the manifest's own directory
+static std::string manifestEntry(const fs::path &manifestDir, const std::string &entry) {
+    fs::path path(entry);
+    if (entry.empty() || path.is_absolute()) {
+        return entry;
+    }
+    return (manifestDir / path).string();
+}
+
+//one test file named on the command line, before output names are chosen
+struct BatchInput {
+    std::string testFile;
+    std::string groundTruthFile;
+    bool fromPattern; //matched by a wildcard rather than named explicitly
+};
+
+//expand one batch input:
+//  a pattern with '*' or '?' in its file name matches test files in that directory,
+//  a .csv file (in any case) is a single test file,
+//  anything else is a manifest with one "test_file[,ground_truth_file]" per line,
+//  where relative paths are relative to the manifest's directory
+static bool addBatchInput(std::vector<BatchInput> &inputs, const std::string &input) {
+    fs::path path(input);
+    std::string name = path.filename().string();
+
+    if (name.find_first_of("*?") != std::string::npos) {
+        fs::path dir = path.has_parent_path() ? path.parent_path() : fs::path(".");
+        std::error_code ec;
+        std::vector<std::string> matches;
+        for (const fs::directory_entry &entry : fs::directory_iterator(dir, ec)) {
+            if (entry.is_regular_file() && wildcardMatch(name, entry.path().filename().string())) {
+                matches.push_back(entry.path().string());
+            }
+        }
+        if (ec) {
+            std::cerr << "Error reading directory: " << dir.string() << std::endl;
+            return false;
+        }
+        std::sort(matches.begin(), matches.end());
+        for (const std::string &match : matches) {
+            inputs.push_back({match, "", true});
+        }
+        return true;
+    }
+
+    if (isCSVFile(path)) {
+        inputs.push_back({input, "", false});
+        return true;
+    }
+
+    std::ifstream manifest(input);
+    if (!manifest.is_open()) {
+        std::cerr << "Error opening batch manifest: " << input << std::endl;
+        return false;
+    }
+    fs::path manifestDir = path.parent_path();
+    std::string line;
+    while (std::getline(manifest, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t comma = line.find(',');
+        if (comma == std::string::npos) {
+            inputs.push_back({manifestEntry(manifestDir, line), "", false});
+        } else {
+            inputs.push_back({manifestEntry(manifestDir, line.substr(0, comma)),
+                              manifestEntry(manifestDir, line.substr(comma + 1)), false});
+        }
+    }
+    return true;
+}
+
+//a key that is the same for every spelling of one file's path
+static std::string pathKey(const std::string &file) {
+    std::error_code ec;
+    fs::path canonical = fs::weakly_canonical(file, ec);
+    return ec ? fs::path(file).lexically_normal().string() : canonical.string();
+}
+
+//output name for a test file from its whole path: "hourly/a/test.csv" -> "hourly_a_test"
+static std::string pathName(const std::string &file) {
+    fs::path path = fs::path(file).lexically_normal();
+    path.replace_extension();
+    std::string name;
+    for (const fs::path &part : path.relative_path()) {
+        std::string piece = part.string();
+        if (piece.empty() || piece == "." || piece == "..") {
+            continue;
+        }
+        name += (name.empty() ? "" : "_") + piece;
+    }
+    return name;
+}
+
+//turn the inputs into jobs with one output pair each
+//  a file listed more than once is scored once,
+//  a file matched by a wildcard that some job uses as ground truth is not scored,
+//  outputs are named after the file name, or after the whole path when file names repeat,
+//  with a numeric suffix as a last resort, so no two jobs write the same file
+static std::vector<BatchJob> makeBatchJobs(const std::vector<BatchInput> &inputs, const std::string &outputDir) {
+    std::set<std::string> groundTruth;
+    for (const BatchInput &input : inputs) {
+        if (!input.groundTruthFile.empty()) {
+            groundTruth.insert(pathKey(input.groundTruthFile));
+        }
+    }
+
+    std::vector<BatchInput> kept;
+    std::set<std::string> seen;
+    for (const BatchInput &input : inputs) {
+        std::string key = pathKey(input.testFile);
+        if (input.fromPattern && groundTruth.count(key)) {
+            continue;
+        }
+        if (!seen.insert(key).second) {
+            continue;
+        }
+        kept.push_back(input);
+    }
+
+    std::map<std::string, size_t> stemCount;
+    for (const BatchInput &input : kept) {
+        stemCount[fs::path(input.testFile).stem().string()]++;
+    }
+
+    std::vector<BatchJob> jobs;
+    std::set<std::string> usedNames;
+    for (const BatchInput &input : kept) {
+        std::string name = fs::path(input.testFile).stem().string();
+        if (stemCount[name] > 1) {
+            name = pathName(input.testFile);
+        }
+        std::string unique = name;
+        for (size_t n = 2; !usedNames.insert(unique).second; ++n) {
+            unique = name + "_" + std::to_string(n);
+        }
+
+        BatchJob job;
+        job.testFile = input.testFile;
+        job.groundTruthFile = input.groundTruthFile;
+        job.resultFile = (fs::path(outputDir) / (unique + "_results.csv")).string();
+        job.accuracyFile = (fs::path(outputDir) / (unique + "_accuracy.txt")).string();
+        jobs.push_back(job);
+    }
+    return jobs;
+}
 
 int main(int argc, char* argv[]) {
+    std::string program = argv[0];
+
+    //check the CSV block indexer against the line parser on the given files
+    if (argc >= 2 && std::string(argv[1]) == "--test-csv") {
+        SentimentClassifier classifier;
+        bool ok = classifier.testCSVIndexer();
+        for (int i = 2; i < argc; ++i) {
+            ok = classifier.testCSVIndexer(argv[i]) && ok;
+        }
+        return ok ? 0 : 1;
+    }
+
+    //check the single-pass tokenizer on hand-written cases
+    if (argc == 2 && std::string(argv[1]) == "--test-tokenizer") {
+        SentimentClassifier classifier;
+        return classifier.testTweetTokenizer() ? 0 : 1;
+    }
+
+    //optional --fused flag selects the single-pass tokenizer
+    bool fused = false;
+    if (argc >= 2 && std::string(argv[1]) == "--fused") {
+        fused = true;
+        --argc;
+        ++argv;
+    }
+
+    //batch mode: train once, then score every listed test file on all cores
+    if (argc >= 2 && std::string(argv[1]) == "--batch") {
+        if (argc < 5) {
+            std::cerr << "Usage: " << program << " [--fused] --batch <training_data> <output_dir> <manifest_or_pattern>..." << std::endl;
+            return 1;
+        }
+        std::string trainingDataFile = argv[2];
+        std::string outputDir = argv[3];
+
+        std::vector<BatchInput> inputs;
+        for (int i = 4; i < argc; ++i) {
+            if (!addBatchInput(inputs, argv[i])) {
+                return 1;
+            }
+        }
+        std::vector<BatchJob> jobs = makeBatchJobs(inputs, outputDir);
+
+        std::error_code ec;
+        fs::create_directories(outputDir, ec);
+        if (ec) {
+            std::cerr << "Error creating output directory: " << outputDir << " (" << ec.message() << ")" << std::endl;
+            return 1;
+        }
+
+        SentimentClassifier classifier;
+        classifier.setFusedTokenizer(fused);
+
+        std::cout << "Training the classifier..." << std::endl;
+        classifier.train(trainingDataFile);
+
+        size_t threads = std::thread::hardware_concurrency();
+        std::cout << "Predicting " << jobs.size() << " files on " << (threads ? threads : 1) << " threads..." << std::endl;
+        size_t failed = classifier.predictBatch(jobs, threads);
+
+        std::cout << "Results written to: " << outputDir << std::endl;
+        if (failed > 0) {
+            std::cerr << failed << " of " << jobs.size() << " files failed" << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
     //check for the correct number of command-line arguments
     if (argc != 5) {
-        std::cerr << "Usage: " << argv[0] << " <training_data> <test_data> <ground_truth> <output_prefix>" << std::endl;
+        std::cerr << "Usage: " << program << " [--fused] <training_data> <test_data> <ground_truth> <output_prefix>" << std::endl;
+        std::cerr << "       " << program << " [--fused] --batch <training_data> <output_dir> <manifest_or_pattern>..." << std::endl;
+        std::cerr << "       " << program << " --test-csv <csv_file>..." << std::endl;
+        std::cerr << "       " << program << " --test-tokenizer" << std::endl;
         return 1;
     }
 
@@ -23,6 +289,7 @@ int main(int argc, char* argv[]) {
     //output files
     std::string resultsFile = outputPrefix + "_results.csv";
     std::string accuracyFile = outputPrefix + "_accuracy.txt";
+    std::string thresholdsFile = outputPrefix + "_thresholds.txt";
 
     //output the file names for debugging
     std::cout << "Training data file: " << trainingDataFile << std::endl;
@@ -30,9 +297,11 @@ int main(int argc, char* argv[]) {
     std::cout << "Ground truth file: " << groundTruthFile << std::endl;
     std::cout << "Results file: " << resultsFile << std::endl;
     std::cout << "Accuracy file: " << accuracyFile << std::endl;
+    std::cout << "Thresholds file: " << thresholdsFile << std::endl;
 
     // create an instance of SentimentClassifier
     SentimentClassifier classifier;
+    classifier.setFusedTokenizer(fused);
 
     //train the classifier
     std::cout << "Training the classifier..." << std::endl;
@@ -44,10 +313,12 @@ int main(int argc, char* argv[]) {
 
     //evaluate predictions
     std::cout << "Evaluating predictions..." << std::endl;
-    classifier.evaluatePredictions(groundTruthFile, accuracyFile);
+    classifier.evaluatePredictions(groundTruthFile, accuracyFile, thresholdsFile);
 
     std::cout << "Results written to: " << resultsFile << std::endl;
     std::cout << "Accuracy and errors written to: " << accuracyFile << std::endl;
+    std::cout << "Threshold sweep written to: " << thresholdsFile
+              << " (best threshold: " << classifier.getThreshold() << ")" << std::endl;
 
     return 0;
 }